@@ -4,11 +4,13 @@
 // Initialize KepecsWheel with wheel type 2 (DS3231)
 // Use wheel type 1 for PCF8523
 KepecsWheel wheel; // Default constructor uses type 2 (DS3231)
+// KepecsWheelT<BoardDS3231> wheel; // Same board, resolved at compile time
 Hublink hublink(SD_CS);
 
-int SLEEP_TIME_SECONDS = 10;
-int SYNC_EVERY_MINUTES = 360; // 4 hours
-int SYNC_FOR_SECONDS = 30;
+// Kept in RTC memory so values from meta.json survive sleep
+RTC_DATA_ATTR int SLEEP_TIME_SECONDS = 10;
+RTC_DATA_ATTR int SYNC_EVERY_MINUTES = 360; // 4 hours
+RTC_DATA_ATTR int SYNC_FOR_SECONDS = 30;
 
 void onTimestampReceived(uint32_t timestamp)
 {
@@ -21,6 +23,9 @@ void setup()
   Serial.begin(115200);
   Serial.println("KepecsWheel Basic Example");
 
+  // Optional: stage rows in internal flash and move them to SD in batches
+  // wheel.setStorageMode(StorageMode::FLASH_STAGED);
+
   if (!wheel.begin())
   {
     Serial.println("Failed to initialize KepecsWheel!");
@@ -33,15 +38,20 @@ void setup()
   // log and increment log count
   wheel.logData();
 
-  // loads vars from meta.json on hard reset
-  if (wheel.reinit())
+  // uses logCount to determine if it should sync
+  bool syncNow = wheel.shouldSync(SLEEP_TIME_SECONDS, SYNC_EVERY_MINUTES);
+
+  // loads vars from meta.json; with flash staging the SD card is only
+  // touched on cold boot and sync wakes
+  bool staged = (wheel.getStorageMode() == StorageMode::FLASH_STAGED);
+  if (staged ? (!wheel.isWakeFromSleep() || syncNow) : wheel.reinit())
   {
     beginHublink();
   }
 
-  // uses logCount to determine if it should sync
-  if (wheel.shouldSync(SLEEP_TIME_SECONDS, SYNC_EVERY_MINUTES))
+  if (syncNow)
   {
+    wheel.prepareSync();            // writes staged, summary and health rows first
     hublink.sync(SYNC_FOR_SECONDS); // force sync
   }
 
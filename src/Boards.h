@@ -0,0 +1,31 @@
+#ifndef BOARDS_H
+#define BOARDS_H
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include "SharedDefs.h"
+
+// Board traits resolved at compile time by KepecsWheelT<Board>.
+// A new board revision is a new traits struct.
+
+// v1 board
+struct BoardPCF8523
+{
+    typedef RTC_PCF8523 RTCDriver;
+    static constexpr RTCType rtcType() { return RTCType::PCF8523; }
+    static constexpr uint8_t sdCSPin() { return 10; }
+    static constexpr gpio_num_t sensorPin() { return GPIO_NUM_18; }
+    static constexpr const char *name() { return "PCF8523"; }
+};
+
+// v2 board
+struct BoardDS3231
+{
+    typedef RTC_DS3231 RTCDriver;
+    static constexpr RTCType rtcType() { return RTCType::DS3231; }
+    static constexpr uint8_t sdCSPin() { return A0; }
+    static constexpr gpio_num_t sensorPin() { return GPIO_NUM_16; } // GPIO16/A2
+    static constexpr const char *name() { return "DS3231"; }
+};
+
+#endif // BOARDS_H
@@ -0,0 +1,59 @@
+#ifndef BUILD_STAMP_H
+#define BUILD_STAMP_H
+
+#include <stdint.h>
+
+// Compile-time conversion of __DATE__ ("Mmm dd yyyy") and __TIME__ ("hh:mm:ss")
+// to seconds since 1970, so no parsing happens at runtime.
+namespace BuildStamp
+{
+    constexpr uint16_t DAYS_BEFORE_MONTH[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+    constexpr int digit(char c)
+    {
+        return (c >= '0' && c <= '9') ? c - '0' : 0; // __DATE__ pads the day with a space
+    }
+
+    constexpr int month(const char *date)
+    {
+        return date[0] == 'J'   ? (date[1] == 'a' ? 1 : (date[2] == 'n' ? 6 : 7))
+               : date[0] == 'F' ? 2
+               : date[0] == 'M' ? (date[2] == 'r' ? 3 : 5)
+               : date[0] == 'A' ? (date[1] == 'p' ? 4 : 8)
+               : date[0] == 'S' ? 9
+               : date[0] == 'O' ? 10
+               : date[0] == 'N' ? 11
+                                : 12;
+    }
+
+    constexpr int day(const char *date) { return digit(date[4]) * 10 + digit(date[5]); }
+
+    constexpr int year(const char *date)
+    {
+        return digit(date[7]) * 1000 + digit(date[8]) * 100 + digit(date[9]) * 10 + digit(date[10]);
+    }
+
+    constexpr bool isLeap(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+    constexpr int leapsBefore(int y) { return (y - 1) / 4 - (y - 1) / 100 + (y - 1) / 400; }
+
+    constexpr uint32_t daysSince1970(int y, int m, int d)
+    {
+        return (uint32_t)(365 * (y - 1970) + leapsBefore(y) - leapsBefore(1970) +
+                          DAYS_BEFORE_MONTH[m - 1] + ((m > 2 && isLeap(y)) ? 1 : 0) + d - 1);
+    }
+
+    constexpr uint32_t secondsOfDay(const char *time)
+    {
+        return (uint32_t)((digit(time[0]) * 10 + digit(time[1])) * 3600 +
+                          (digit(time[3]) * 10 + digit(time[4])) * 60 +
+                          digit(time[6]) * 10 + digit(time[7]));
+    }
+
+    constexpr uint32_t timestamp(const char *date, const char *time)
+    {
+        return daysSince1970(year(date), month(date), day(date)) * 86400UL + secondsOfDay(time);
+    }
+}
+
+#endif // BUILD_STAMP_H
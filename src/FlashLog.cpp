@@ -0,0 +1,323 @@
+#include "FlashLog.h"
+#include <string.h>
+
+FlashLog::FlashLog() : _storage(nullptr), _sectorCount(0), _headSequence(0), _head{0, 0}, _tail{0, 0}
+{
+    static_assert(sizeof(SectorHeader) == FLASH_LOG_HEADER_SIZE, "sector header size");
+    static_assert(sizeof(Entry) == FLASH_LOG_ENTRY_SIZE, "entry size");
+}
+
+bool FlashLog::begin(FlashLogStorage *storage)
+{
+    _storage = nullptr;
+    _sectorCount = storage->size() / FLASH_LOG_SECTOR_SIZE;
+    if (_sectorCount < 2)
+    {
+        return false;
+    }
+    _storage = storage;
+
+    // Newest sector holds the head, oldest sector starts the ring
+    bool found = false;
+    uint16_t headSector = 0;
+    uint16_t oldestSector = 0;
+    uint32_t maxSequence = 0;
+    uint32_t minSequence = UINT32_MAX;
+    for (uint16_t s = 0; s < _sectorCount; s++)
+    {
+        SectorHeader header;
+        if (!_storage->read((uint32_t)s * FLASH_LOG_SECTOR_SIZE, &header, sizeof(header)) ||
+            header.magic != FLASH_LOG_SECTOR_MAGIC)
+        {
+            continue;
+        }
+        found = true;
+        if (header.sequence >= maxSequence)
+        {
+            maxSequence = header.sequence;
+            headSector = s;
+        }
+        if (header.sequence < minSequence)
+        {
+            minSequence = header.sequence;
+            oldestSector = s;
+        }
+    }
+
+    if (!found)
+    {
+        // Fresh partition
+        _headSequence = 0;
+        if (!startSector(0, 1))
+        {
+            _storage = nullptr;
+            return false;
+        }
+        _headSequence = 1;
+        _head = {0, 0};
+        _tail = _head;
+        return true;
+    }
+
+    // Head is the first blank slot; torn writes leave non-blank slots and are skipped
+    Entry entry;
+    _headSequence = maxSequence;
+    _head = {headSector, 0};
+    while (_head.slot < FLASH_LOG_ENTRIES_PER_SECTOR && readEntry(_head, &entry) != ENTRY_BLANK)
+    {
+        _head.slot++;
+    }
+
+    // Migrated entries form a prefix of the ring, so binary search for the tail
+    Position oldest = {oldestSector, 0};
+    uint32_t lo = 0;
+    uint32_t hi = distance(oldest, _head);
+    uint32_t end = hi;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (readEntry(positionAt(oldest, mid), &entry) == ENTRY_DONE)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    _tail = (lo == end) ? _head : positionAt(oldest, lo);
+    return true;
+}
+
+bool FlashLog::append(const FlashLogRecord &record)
+{
+    if (!_storage)
+    {
+        return false;
+    }
+    if (distance(_tail, _head) >= capacity())
+    {
+        return false; // Full, one sector is always kept free for the next erase
+    }
+    if (_head.slot >= FLASH_LOG_ENTRIES_PER_SECTOR && !advanceHead())
+    {
+        return false;
+    }
+
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.timestamp = record.timestamp;
+    entry.voltage = record.voltage;
+    entry.count = record.count;
+    entry.state = FLASH_LOG_STATE_PENDING;
+    entry.crc = crc32(&entry, offsetof(Entry, state));
+
+    // Advance even if the write fails so a damaged slot is never reused
+    Position pos = _head;
+    _head.slot++;
+    return _storage->write(entryOffset(pos), &entry, sizeof(entry));
+}
+
+uint16_t FlashLog::peek(FlashLogRecord *records, uint16_t maxRecords)
+{
+    if (!_storage)
+    {
+        return 0;
+    }
+
+    Entry entry;
+    Position pos = _tail;
+    uint16_t found = 0;
+    while (found < maxRecords && !(pos.sector == _head.sector && pos.slot == _head.slot))
+    {
+        if (readEntry(pos, &entry) == ENTRY_PENDING)
+        {
+            records[found].timestamp = entry.timestamp;
+            records[found].voltage = entry.voltage;
+            records[found].count = entry.count;
+            found++;
+        }
+        step(&pos);
+    }
+    return found;
+}
+
+bool FlashLog::consume(uint16_t count)
+{
+    if (!_storage)
+    {
+        return false;
+    }
+
+    Entry entry;
+    while (count > 0 && !(_tail.sector == _head.sector && _tail.slot == _head.slot))
+    {
+        EntryStatus status = readEntry(_tail, &entry);
+        if (status == ENTRY_PENDING)
+        {
+            count--;
+        }
+        if ((status == ENTRY_PENDING || status == ENTRY_CORRUPT) && !markDone(_tail))
+        {
+            return false;
+        }
+        step(&_tail);
+    }
+    return count == 0;
+}
+
+uint32_t FlashLog::pendingCount()
+{
+    if (!_storage)
+    {
+        return 0;
+    }
+    return distance(_tail, _head);
+}
+
+uint8_t FlashLog::fillPercent()
+{
+    if (!_storage)
+    {
+        return 0;
+    }
+    uint32_t pending = pendingCount();
+    return pending >= capacity() ? 100 : (uint8_t)(pending * 100 / capacity());
+}
+
+uint32_t FlashLog::capacity()
+{
+    // append() keeps one sector free for the next erase
+    return (uint32_t)(_sectorCount - 1) * FLASH_LOG_ENTRIES_PER_SECTOR;
+}
+
+bool FlashLog::startSector(uint16_t sector, uint32_t sequence)
+{
+    uint32_t offset = (uint32_t)sector * FLASH_LOG_SECTOR_SIZE;
+    if (!_storage->eraseSector(offset))
+    {
+        return false;
+    }
+
+    SectorHeader header;
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = FLASH_LOG_SECTOR_MAGIC;
+    header.sequence = sequence;
+    return _storage->write(offset, &header, sizeof(header));
+}
+
+bool FlashLog::advanceHead()
+{
+    uint16_t next = (_head.sector + 1) % _sectorCount;
+    bool empty = _tail.sector == _head.sector && _tail.slot == _head.slot;
+    if (!empty && _tail.sector == next)
+    {
+        return false; // Never erase a sector that still holds pending entries
+    }
+    if (!startSector(next, _headSequence + 1))
+    {
+        return false;
+    }
+    _headSequence++;
+    _head = {next, 0};
+    if (empty)
+    {
+        _tail = _head;
+    }
+    return true;
+}
+
+FlashLog::EntryStatus FlashLog::readEntry(const Position &pos, Entry *entry)
+{
+    if (!_storage->read(entryOffset(pos), entry, sizeof(Entry)))
+    {
+        return ENTRY_CORRUPT;
+    }
+
+    const uint8_t *bytes = (const uint8_t *)entry;
+    bool blank = true;
+    for (size_t i = 0; i < sizeof(Entry); i++)
+    {
+        if (bytes[i] != 0xFF)
+        {
+            blank = false;
+            break;
+        }
+    }
+    if (blank)
+    {
+        return ENTRY_BLANK;
+    }
+    if (entry->state != FLASH_LOG_STATE_PENDING)
+    {
+        return ENTRY_DONE;
+    }
+    if (entry->crc != crc32(entry, offsetof(Entry, state)))
+    {
+        return ENTRY_CORRUPT;
+    }
+    return ENTRY_PENDING;
+}
+
+bool FlashLog::markDone(const Position &pos)
+{
+    uint16_t done = 0;
+    return _storage->write(entryOffset(pos) + offsetof(Entry, state), &done, sizeof(done));
+}
+
+bool FlashLog::step(Position *pos)
+{
+    if (pos->sector == _head.sector && pos->slot == _head.slot)
+    {
+        return false;
+    }
+    pos->slot++;
+    if (pos->slot >= FLASH_LOG_ENTRIES_PER_SECTOR && !(pos->sector == _head.sector && pos->slot == _head.slot))
+    {
+        pos->sector = (pos->sector + 1) % _sectorCount;
+        pos->slot = 0;
+    }
+    return true;
+}
+
+FlashLog::Position FlashLog::positionAt(const Position &origin, uint32_t distance)
+{
+    uint32_t total = (uint32_t)_sectorCount * FLASH_LOG_ENTRIES_PER_SECTOR;
+    uint32_t index = ((uint32_t)origin.sector * FLASH_LOG_ENTRIES_PER_SECTOR + origin.slot + distance) % total;
+    Position pos = {(uint16_t)(index / FLASH_LOG_ENTRIES_PER_SECTOR), (uint16_t)(index % FLASH_LOG_ENTRIES_PER_SECTOR)};
+    return pos;
+}
+
+uint32_t FlashLog::distance(const Position &from, const Position &to)
+{
+    if (from.sector == to.sector && from.slot == to.slot)
+    {
+        return 0;
+    }
+    uint32_t total = (uint32_t)_sectorCount * FLASH_LOG_ENTRIES_PER_SECTOR;
+    uint32_t fromIndex = (uint32_t)from.sector * FLASH_LOG_ENTRIES_PER_SECTOR + from.slot;
+    uint32_t toIndex = (uint32_t)to.sector * FLASH_LOG_ENTRIES_PER_SECTOR + to.slot;
+    uint32_t d = (toIndex + total - fromIndex) % total;
+    return d == 0 ? total : d; // A full head slot can alias the start of the next sector
+}
+
+uint32_t FlashLog::entryOffset(const Position &pos)
+{
+    return (uint32_t)pos.sector * FLASH_LOG_SECTOR_SIZE + FLASH_LOG_HEADER_SIZE +
+           (uint32_t)pos.slot * FLASH_LOG_ENTRY_SIZE;
+}
+
+uint32_t FlashLog::crc32(const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (uint8_t b = 0; b < 8; b++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
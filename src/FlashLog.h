@@ -0,0 +1,98 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+// Platform-independent core so the format and recovery logic can be
+// exercised on the host against a simulated partition.
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_LOG_SECTOR_SIZE 4096
+#define FLASH_LOG_HEADER_SIZE 16
+#define FLASH_LOG_ENTRY_SIZE 16
+#define FLASH_LOG_ENTRIES_PER_SECTOR ((FLASH_LOG_SECTOR_SIZE - FLASH_LOG_HEADER_SIZE) / FLASH_LOG_ENTRY_SIZE)
+#define FLASH_LOG_SECTOR_MAGIC 0x574C4F47 // "WLOG"
+#define FLASH_LOG_STATE_PENDING 0xFFFF
+
+// One logged row
+struct FlashLogRecord
+{
+    uint32_t timestamp;
+    float voltage;
+    uint16_t count;
+};
+
+// Raw flash access; erased bytes read back as 0xFF and writes may only clear bits
+class FlashLogStorage
+{
+public:
+    virtual ~FlashLogStorage() {}
+    virtual uint32_t size() = 0;
+    virtual bool read(uint32_t offset, void *data, size_t length) = 0;
+    virtual bool write(uint32_t offset, const void *data, size_t length) = 0;
+    virtual bool eraseSector(uint32_t offset) = 0;
+};
+
+// Circular, wear-leveled append log; sectors are reused in ring order and
+// every entry carries its own CRC so torn writes are skipped on recovery
+class FlashLog
+{
+public:
+    FlashLog();
+    bool begin(FlashLogStorage *storage); // Scan flash and recover head/tail
+    bool append(const FlashLogRecord &record);
+    uint16_t peek(FlashLogRecord *records, uint16_t maxRecords); // Oldest pending first
+    bool consume(uint16_t count);                                // Mark records from peek() as migrated
+    uint32_t pendingCount();
+    uint8_t fillPercent();
+    bool isInitialized() const { return _storage != nullptr; }
+
+private:
+    struct Position
+    {
+        uint16_t sector;
+        uint16_t slot;
+    };
+
+    struct SectorHeader
+    {
+        uint32_t magic;
+        uint32_t sequence;
+        uint32_t reserved[2];
+    };
+
+    struct Entry
+    {
+        uint32_t timestamp;
+        float voltage;
+        uint16_t count;
+        uint16_t state; // Not covered by the CRC so it can be cleared in place
+        uint32_t crc;
+    };
+
+    enum EntryStatus
+    {
+        ENTRY_BLANK,
+        ENTRY_PENDING,
+        ENTRY_DONE,
+        ENTRY_CORRUPT
+    };
+
+    FlashLogStorage *_storage;
+    uint16_t _sectorCount;
+    uint32_t _headSequence;
+    Position _head; // Next slot to write
+    Position _tail; // Oldest pending entry, equals _head when empty
+
+    bool startSector(uint16_t sector, uint32_t sequence);
+    bool advanceHead();
+    uint32_t capacity(); // Entries that may be pending at once
+    EntryStatus readEntry(const Position &pos, Entry *entry);
+    bool markDone(const Position &pos);
+    bool step(Position *pos); // Move to the next slot, false at the head
+    Position positionAt(const Position &origin, uint32_t distance);
+    uint32_t distance(const Position &from, const Position &to);
+    uint32_t entryOffset(const Position &pos);
+    static uint32_t crc32(const void *data, size_t length);
+};
+
+#endif // FLASH_LOG_H
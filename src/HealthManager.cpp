@@ -0,0 +1,149 @@
+#include "HealthManager.h"
+#include <RTClib.h>
+
+// Initialize static members
+RTC_NOINIT_ATTR HealthBlock HealthManager::_block;
+
+const char *HealthManager::_names[HEALTH_COUNTER_COUNT] = {
+    "timer_wakes", "poweron_resets", "brownout_resets", "watchdog_resets", "panic_resets", "other_resets",
+    "sd_init_fail", "sd_open_fail", "sd_write_fail", "flash_fail", "rtc_init_fail", "rtc_lost_power",
+    "battery_init_fail", "battery_retries", "ulp_load_fail", "overflows"};
+
+void HealthManager::begin()
+{
+    if (RTCBlock::isValid(_block, HEALTH_MAGIC))
+    {
+        return;
+    }
+    RTCBlock::reset(_block, HEALTH_MAGIC);
+    _block.lastError = HEALTH_NO_ERROR;
+    seal();
+}
+
+void HealthManager::recordWake(esp_sleep_wakeup_cause_t wakeCause, esp_reset_reason_t resetReason)
+{
+    if (wakeCause == ESP_SLEEP_WAKEUP_TIMER)
+    {
+        record(HEALTH_TIMER_WAKES);
+        return;
+    }
+
+    switch (resetReason)
+    {
+    case ESP_RST_POWERON:
+        record(HEALTH_POWERON_RESETS);
+        break;
+    case ESP_RST_BROWNOUT:
+        record(HEALTH_BROWNOUT_RESETS);
+        break;
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+        record(HEALTH_WATCHDOG_RESETS);
+        break;
+    case ESP_RST_PANIC:
+        record(HEALTH_PANIC_RESETS);
+        break;
+    default:
+        record(HEALTH_OTHER_RESETS);
+        break;
+    }
+}
+
+void HealthManager::record(HealthCounter counter, uint16_t amount)
+{
+    uint16_t &value = _block.counters[counter];
+    if (value > UINT16_MAX - amount)
+    {
+        value = UINT16_MAX;
+        if (_block.counters[HEALTH_OVERFLOWS] < UINT16_MAX)
+        {
+            _block.counters[HEALTH_OVERFLOWS]++;
+        }
+    }
+    else
+    {
+        value += amount;
+    }
+    seal();
+}
+
+void HealthManager::recordError(HealthCounter counter)
+{
+    _block.lastError = counter;
+    record(counter);
+}
+
+void HealthManager::setTime(uint32_t timestamp)
+{
+    _block.timestamp = timestamp;
+    seal();
+}
+
+void HealthManager::addAwakeTime(uint32_t ms)
+{
+    _block.awakeMs += ms;
+    seal();
+}
+
+bool HealthManager::isFlushDue() const
+{
+    return _block.timestamp - _block.lastFlush >= HEALTH_FLUSH_SECONDS;
+}
+
+bool HealthManager::flush(uint32_t sdFrequency)
+{
+    bool isNew = !SD.exists(HEALTH_FILE);
+    File file = SD.open(HEALTH_FILE, FILE_APPEND);
+    if (!file)
+    {
+        Serial.println("Failed to open health file");
+        return false;
+    }
+
+    if (isNew)
+    {
+        String header = "datetime,awake_ms,sd_clock_hz";
+        for (uint8_t i = 0; i < HEALTH_COUNTER_COUNT; i++)
+        {
+            header += ",";
+            header += _names[i];
+        }
+        header += ",last_error";
+        if (!file.println(header))
+        {
+            file.close();
+            return false;
+        }
+    }
+
+    DateTime dt(_block.timestamp);
+    char prefix[56];
+    snprintf(prefix, sizeof(prefix), "%04d-%02d-%02d %02d:%02d:%02d,%lu,%lu",
+             dt.year(), dt.month(), dt.day(),
+             dt.hour(), dt.minute(), dt.second(),
+             (unsigned long)_block.awakeMs, (unsigned long)sdFrequency);
+    String row = prefix;
+    for (uint8_t i = 0; i < HEALTH_COUNTER_COUNT; i++)
+    {
+        row += ",";
+        row += String((unsigned int)_block.counters[i]);
+    }
+    row += ",";
+    row += (_block.lastError < HEALTH_COUNTER_COUNT) ? _names[_block.lastError] : "";
+
+    bool success = file.println(row);
+    file.close();
+    if (!success)
+    {
+        return false;
+    }
+
+    // Start the next row from zero
+    memset(_block.counters, 0, sizeof(_block.counters));
+    _block.awakeMs = 0;
+    _block.lastError = HEALTH_NO_ERROR;
+    _block.lastFlush = _block.timestamp;
+    seal();
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef HEALTH_MANAGER_H
+#define HEALTH_MANAGER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "SharedDefs.h"
+#include "RTCBlock.h"
+
+#define HEALTH_MAGIC 0x484C5448      // "HLTH"
+#define HEALTH_FLUSH_SECONDS 3600    // Minimum spacing of HEALTH.csv rows outside of sync
+#define HEALTH_FILE "/HEALTH.csv"
+#define HEALTH_NO_ERROR 0xFF
+
+// Counted events, in HEALTH.csv column order
+enum HealthCounter : uint8_t
+{
+    HEALTH_TIMER_WAKES,
+    HEALTH_POWERON_RESETS,
+    HEALTH_BROWNOUT_RESETS,
+    HEALTH_WATCHDOG_RESETS,
+    HEALTH_PANIC_RESETS,
+    HEALTH_OTHER_RESETS,
+    HEALTH_SD_INIT_FAIL,
+    HEALTH_SD_OPEN_FAIL,
+    HEALTH_SD_WRITE_FAIL,
+    HEALTH_FLASH_FAIL,
+    HEALTH_RTC_INIT_FAIL,
+    HEALTH_RTC_LOST_POWER,
+    HEALTH_BATTERY_INIT_FAIL,
+    HEALTH_BATTERY_RETRIES,
+    HEALTH_ULP_LOAD_FAIL,
+    HEALTH_OVERFLOWS, // Counters that saturated since the last row
+    HEALTH_COUNTER_COUNT
+};
+
+// Counters since the last HEALTH.csv row, kept across deep sleep and resets
+struct HealthBlock
+{
+    uint32_t magic;
+    uint32_t timestamp; // Latest RTC time seen
+    uint32_t lastFlush; // RTC time of the last HEALTH.csv row
+    uint32_t awakeMs;
+    uint16_t counters[HEALTH_COUNTER_COUNT];
+    uint8_t lastError; // HealthCounter of the latest failure, HEALTH_NO_ERROR if none
+    uint8_t reserved[3];
+    uint32_t checksum;
+};
+
+class HealthManager
+{
+public:
+    void begin(); // Validate the block, starting fresh after power loss
+    void recordWake(esp_sleep_wakeup_cause_t wakeCause, esp_reset_reason_t resetReason);
+    void record(HealthCounter counter, uint16_t amount = 1);
+    void recordError(HealthCounter counter); // Also sets the last error code
+    void setTime(uint32_t timestamp);
+    void addAwakeTime(uint32_t ms);
+    bool isFlushDue() const;
+    bool flush(uint32_t sdFrequency); // Append a HEALTH.csv row and clear, SD must be mounted
+    uint8_t getLastError() const { return _block.lastError; }
+
+private:
+    void seal() { RTCBlock::seal(_block); }
+    static const char *_names[HEALTH_COUNTER_COUNT];
+
+    RTC_NOINIT_ATTR static HealthBlock _block;
+};
+
+#endif // HEALTH_MANAGER_H
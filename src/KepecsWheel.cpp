@@ -2,8 +2,11 @@
 #include "KepecsWheel.h"
 
 // Initialize static members
-RTC_DATA_ATTR uint32_t KepecsWheel::_logCount = 0;
-uint8_t SD_CS = 10; // Default to 10, will be updated based on RTC type
+RTC_DATA_ATTR uint32_t KepecsWheelBase::_logCount = 0;
+RTC_DATA_ATTR uint32_t KepecsWheelBase::_lastMigrationDay = 0;
+RTC_DATA_ATTR uint32_t KepecsWheelBase::_lastMigrationAttempt = 0;
+RTC_DATA_ATTR bool KepecsWheelBase::_hasMigrationFailed = false;
+uint8_t SD_CS = 10; // Default to 10, updated by the board constructor
 
 // I2C address for RTCs
 #define RTC_ADDRESS 0x68
@@ -12,30 +15,66 @@ uint8_t SD_CS = 10; // Default to 10, will be updated based on RTC type
 #define DS3231_TEMP_REG 0x11
 
 KepecsWheel::KepecsWheel(uint8_t wheelType)
+    : KepecsWheelBase((wheelType == 2) ? BoardDS3231::sdCSPin() : BoardPCF8523::sdCSPin(),
+                      (wheelType == 2) ? BoardDS3231::sensorPin() : BoardPCF8523::sensorPin()),
+      _rtcType((wheelType == 2) ? BoardDS3231::rtcType() : BoardPCF8523::rtcType())
 {
-    // Set RTC type based on wheel type
-    _rtcType = (wheelType == 2) ? RTCType::DS3231 : RTCType::PCF8523;
 }
 
-void KepecsWheel::updateSDCSPin()
+bool KepecsWheel::begin()
+{
+    beginStorage();
+    Serial.printf("  RTC: Initializing %s\n", (_rtcType == RTCType::DS3231) ? BoardDS3231::name() : BoardPCF8523::name());
+    if (_rtcType == RTCType::DS3231)
+    {
+        bool isRTCInitialized = _ds3231.begin();
+        return finishBegin(isRTCInitialized, _ds3231.lostPower());
+    }
+    bool isRTCInitialized = _pcf8523.begin();
+    return finishBegin(isRTCInitialized, _pcf8523.lostPower());
+}
+
+bool KepecsWheel::logData()
+{
+    if (!canLog())
+    {
+        return false;
+    }
+    return logDataAt(currentTime());
+}
+
+DateTime KepecsWheel::currentTime()
+{
+    return (_rtcType == RTCType::DS3231) ? _ds3231.now() : _pcf8523.now();
+}
+
+void KepecsWheel::adjustRTC(uint32_t timestamp)
 {
     if (_rtcType == RTCType::DS3231)
     {
-        _sdCSPin = A0; // DS3231 board uses A0 for SD_CS
-        SD_CS = A0;    // Update global variable
+        _ds3231.adjustRTC(timestamp);
     }
     else
     {
-        _sdCSPin = 10; // PCF8523 board uses pin 10
-        SD_CS = 10;    // Update global variable
+        _pcf8523.adjustRTC(timestamp);
     }
 }
 
-bool KepecsWheel::begin()
+KepecsWheelBase::KepecsWheelBase(uint8_t sdCSPin, gpio_num_t sensorPin) : _sdCSPin(sdCSPin)
+{
+    SD_CS = sdCSPin; // Set before sketches construct anything that reads it
+    _ulp.setSensorPin(sensorPin);
+}
+
+void KepecsWheelBase::beginStorage()
 {
     esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
     _isWakeFromSleep = (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER);
     Serial.printf("Wakeup reason: %d\n", wakeup_reason);
+    _lastError = HEALTH_NO_ERROR;
+    _health.begin();
+    _health.recordWake(wakeup_reason, esp_reset_reason());
+    _rollup.begin();
 
     // Reset counter on hard reset, increment on timer wakeup
     if (!_isWakeFromSleep)
@@ -49,34 +88,49 @@ bool KepecsWheel::begin()
     Wire.begin();
     delay(10); // Give I2C time to stabilize
 
-    // Update SD_CS pin based on RTC type
-    updateSDCSPin();
-
-    // Now initialize SD with the correct CS pin
-    SPI.begin(SCK, MISO, MOSI, _sdCSPin);
-    if (SD.begin(_sdCSPin, SPI, 1000000))
+    // Flash staging leaves the SD card unmounted on ordinary wakes
+    if (_storageMode == StorageMode::FLASH_STAGED)
     {
-        Serial.println("SD Card initialized.");
-        _isSDInitialized = true;
+        if (_flashStorage.begin() && _flashLog.begin(&_flashStorage))
+        {
+            Serial.printf("  Flash: staging log ready, %lu pending (%d%% full)\n",
+                          (unsigned long)_flashLog.pendingCount(), _flashLog.fillPercent());
+        }
+        else
+        {
+            Serial.println("  Flash: staging log initialization failed");
+            recordError(HEALTH_FLASH_FAIL);
+        }
     }
-    else
+
+    _isSDInitialized = false;
+    if (_storageMode == StorageMode::SD_DIRECT || !_isWakeFromSleep)
     {
-        Serial.println("SD Card initialization failed.");
-        _isSDInitialized = false;
+        // Now initialize SD with the correct CS pin, negotiating the clock on cold boot
+        if (_sd.begin(_sdCSPin, _isWakeFromSleep))
+        {
+            Serial.println("SD Card initialized.");
+            _isSDInitialized = true;
+        }
+        else
+        {
+            Serial.println("SD Card initialization failed.");
+            recordError(HEALTH_SD_INIT_FAIL);
+            _hasSDMountFailed = true;
+        }
     }
+}
 
-    // Initialize RTC based on type
-    Serial.printf("  RTC: Initializing %s\n", (_rtcType == RTCType::DS3231) ? "DS3231" : "PCF8523");
-    _isRTCInitialized = _rtc.begin(_rtcType);
-
-    // Set appropriate ULP sensor pin based on RTC type
-    if (_rtcType == RTCType::DS3231)
+bool KepecsWheelBase::finishBegin(bool isRTCInitialized, bool rtcLostPower)
+{
+    _isRTCInitialized = isRTCInitialized;
+    if (!_isRTCInitialized)
     {
-        _ulp.setSensorPin(GPIO_NUM_16); // v2 DS3231 board uses GPIO16/A2
+        recordError(HEALTH_RTC_INIT_FAIL);
     }
-    else
+    if (rtcLostPower)
     {
-        _ulp.setSensorPin(GPIO_NUM_18); // v1 PCF8523 board uses GPIO18
+        _health.record(HEALTH_RTC_LOST_POWER);
     }
 
     // Initialize battery monitor with detailed debug
@@ -84,6 +138,7 @@ bool KepecsWheel::begin()
     {
         Serial.println("  Battery: failed to begin()");
         _isBatteryMonitorInitialized = false;
+        recordError(HEALTH_BATTERY_INIT_FAIL);
     }
     else
     {
@@ -107,15 +162,26 @@ bool KepecsWheel::begin()
             }
             retries++;
         }
+        if (retries > 0)
+        {
+            _health.record(HEALTH_BATTERY_RETRIES, retries);
+        }
     }
 
-    allInitialized = _isSDInitialized && _isRTCInitialized && _isBatteryMonitorInitialized;
+    // Recover anything staged before a reset
+    if (!_isWakeFromSleep && _isSDInitialized)
+    {
+        migrateToSD();
+    }
+
+    bool isStorageReady = (_storageMode == StorageMode::FLASH_STAGED) ? _flashLog.isInitialized() : _isSDInitialized;
+    allInitialized = isStorageReady && _isRTCInitialized && _isBatteryMonitorInitialized;
     if (!allInitialized)
     {
         _beginFailed = true;
         Serial.print("Failure reason: ");
-        if (!_isSDInitialized)
-            Serial.println("SD Card");
+        if (!isStorageReady)
+            Serial.println((_storageMode == StorageMode::FLASH_STAGED) ? "Flash Log" : "SD Card");
         if (!_isRTCInitialized)
             Serial.println("RTC");
         if (!_isBatteryMonitorInitialized)
@@ -124,12 +190,12 @@ bool KepecsWheel::begin()
     return allInitialized;
 }
 
-bool KepecsWheel::reinit()
+bool KepecsWheelBase::reinit()
 {
     return _isWakeFromSleep || _beginFailed;
 }
 
-bool KepecsWheel::logData()
+bool KepecsWheelBase::canLog()
 {
     // Only log data if we woke from sleep
     if (!_isWakeFromSleep)
@@ -137,17 +203,66 @@ bool KepecsWheel::logData()
         Serial.println("Not waking from sleep, skipping data logging");
         return false;
     }
+    return true;
+}
+
+bool KepecsWheelBase::logDataAt(const DateTime &now)
+{
     digitalWrite(LED_BUILTIN, HIGH);
+    _lastError = HEALTH_NO_ERROR;
+    _health.setTime(now.unixtime());
+
+    float voltage = getBatteryVoltage();
+    int count = (int)(_ulp.getEdgeCount() / 2);
+
+    if (_storageMode == StorageMode::FLASH_STAGED && _flashLog.isInitialized())
+    {
+        FlashLogRecord record = {now.unixtime(), voltage, (uint16_t)count};
+        if (_flashLog.append(record))
+        {
+            Serial.printf("\nStaged data: %s\n\n", formatRow(now, voltage, count).c_str());
+            _rollup.update(now.unixtime(), voltage, (uint16_t)count); // Only rows that were stored
+            incrementLogCount();
+
+            // Migrate once a day, or early if the log is filling up; after a
+            // failure wait before retrying so a dead card is not mounted every wake
+            bool isDue = now.unixtime() / 86400 != _lastMigrationDay ||
+                         _flashLog.fillPercent() >= FLASH_LOG_MIGRATE_PERCENT;
+            bool isBackingOff = _hasMigrationFailed &&
+                                now.unixtime() - _lastMigrationAttempt < FLASH_LOG_RETRY_SECONDS;
+            if (isDue && !isBackingOff)
+            {
+                _lastMigrationAttempt = now.unixtime();
+                if (migrateToSD())
+                {
+                    flushRollups();
+                    flushHealth(false);
+                }
+            }
+            digitalWrite(LED_BUILTIN, LOW);
+            return true;
+        }
+        Serial.println("Flash log full, writing directly to SD");
+        recordError(HEALTH_FLASH_FAIL);
+        migrateToSD();
+    }
+
+    if (!ensureSD())
+    {
+        digitalWrite(LED_BUILTIN, LOW);
+        return false;
+    }
 
-    String currentFile = getCurrentFilename();
+    String currentFile = getFilename(now);
 
     // Check if file exists, create it with header if it doesn't
     if (!SD.exists(currentFile))
     {
         if (!createFile(currentFile))
         {
-            digitalWrite(LED_BUILTIN, HIGH);
-            delay(1000); // linger for a moment on error
+            recordError(HEALTH_SD_OPEN_FAIL);
+            handleSDError();
+            digitalWrite(LED_BUILTIN, LOW);
             return false;
         }
     }
@@ -157,35 +272,38 @@ bool KepecsWheel::logData()
     if (!dataFile)
     {
         Serial.println("Failed to open file for logging: " + currentFile);
-        digitalWrite(LED_BUILTIN, HIGH);
-        delay(1000); // linger for a moment on error
+        recordError(HEALTH_SD_OPEN_FAIL);
+        handleSDError();
+        digitalWrite(LED_BUILTIN, LOW);
         return false;
     }
 
-    DateTime now = _rtc.now();
-
-    char datetime[20];
-    snprintf(datetime, sizeof(datetime), "%04d-%02d-%02d %02d:%02d:%02d",
-             now.year(), now.month(), now.day(),
-             now.hour(), now.minute(), now.second());
-
-    char voltageStr[8];
-    snprintf(voltageStr, sizeof(voltageStr), "%.2f", getBatteryVoltage());
-
-    String dataString = "";
-    dataString = String(datetime) + "," + String(voltageStr) + "," + String((int)(_ulp.getEdgeCount() / 2));
+    String dataString = formatRow(now, voltage, count);
 
     Serial.printf("\nLogging data: %s\n\n", dataString.c_str());
 
     // Write data
     bool success = dataFile.println(dataString);
     dataFile.close();
+    if (!success)
+    {
+        Serial.println("Failed to write data to file: " + currentFile);
+        recordError(HEALTH_SD_WRITE_FAIL);
+        handleSDError();
+    }
+    else
+    {
+        // Skipped after a failed write so a dead card is not probed again
+        _rollup.update(now.unixtime(), voltage, (uint16_t)count);
+        flushRollups();
+        flushHealth(false);
+    }
     incrementLogCount();
     digitalWrite(LED_BUILTIN, LOW);
     return success;
 }
 
-void KepecsWheel::sleep(int seconds)
+void KepecsWheelBase::sleep(int seconds)
 {
     digitalWrite(LED_BUILTIN, LOW);
     if (_isBatteryMonitorInitialized)
@@ -197,20 +315,192 @@ void KepecsWheel::sleep(int seconds)
     esp_sleep_enable_timer_wakeup(microseconds);
     _ulp.clearEdgeCount();
     _ulp.begin();
-    _ulp.start();
+    if (!_ulp.start())
+    {
+        recordError(HEALTH_ULP_LOAD_FAIL);
+    }
+    _health.addAwakeTime(millis());
     esp_deep_sleep_start();
 }
 
-String KepecsWheel::getCurrentFilename()
+String KepecsWheelBase::getFilename(const DateTime &dt)
 {
-    DateTime now = _rtc.now();
     char filename[20];
     snprintf(filename, sizeof(filename), "/WHEEL_%04d%02d%02d.csv",
-             now.year(), now.month(), now.day());
+             dt.year(), dt.month(), dt.day());
     return String(filename);
 }
 
-bool KepecsWheel::createFile(String filename)
+String KepecsWheelBase::formatRow(const DateTime &dt, float voltage, int count)
+{
+    char row[48];
+    snprintf(row, sizeof(row), "%04d-%02d-%02d %02d:%02d:%02d,%.2f,%d",
+             dt.year(), dt.month(), dt.day(),
+             dt.hour(), dt.minute(), dt.second(),
+             voltage, count);
+    return String(row);
+}
+
+bool KepecsWheelBase::ensureSD()
+{
+    // Try at most once per wake
+    if (!_isSDInitialized && !_hasSDMountFailed)
+    {
+        _isSDInitialized = _sd.begin(_sdCSPin, _isWakeFromSleep);
+        _hasSDMountFailed = !_isSDInitialized;
+        if (!_isSDInitialized)
+        {
+            Serial.println("SD Card initialization failed.");
+            recordError(HEALTH_SD_INIT_FAIL);
+        }
+    }
+    return _isSDInitialized;
+}
+
+void KepecsWheelBase::recordError(HealthCounter counter)
+{
+    _health.recordError(counter); // Persisted column, cleared when HEALTH.csv is written
+    _lastError = counter;
+}
+
+void KepecsWheelBase::handleSDError()
+{
+    _isSDInitialized = _sd.handleIOError(); // Probe unmounts the card when no clock works
+    _hasSDMountFailed = !_isSDInitialized;
+}
+
+bool KepecsWheelBase::flushRollups()
+{
+    if (_rollup.pendingCount() == 0)
+    {
+        return true;
+    }
+    if (!ensureSD())
+    {
+        return false;
+    }
+    if (!_rollup.flush())
+    {
+        Serial.println("Failed to write summary rows");
+        recordError(HEALTH_SD_WRITE_FAIL);
+        handleSDError();
+        return false;
+    }
+    return true;
+}
+
+bool KepecsWheelBase::flushHealth(bool force)
+{
+    if (!force && !_health.isFlushDue())
+    {
+        return true;
+    }
+    if (!ensureSD())
+    {
+        return false;
+    }
+    if (!_health.flush(_sd.getFrequency()))
+    {
+        Serial.println("Failed to write health row");
+        recordError(HEALTH_SD_WRITE_FAIL);
+        handleSDError();
+        return false;
+    }
+    return true;
+}
+
+bool KepecsWheelBase::migrateToSD()
+{
+    if (_storageMode != StorageMode::FLASH_STAGED || !_flashLog.isInitialized() ||
+        _flashLog.pendingCount() == 0)
+    {
+        return true;
+    }
+    if (!ensureSD())
+    {
+        _hasMigrationFailed = true;
+        return false;
+    }
+
+    Serial.printf("Migrating %lu staged records to SD\n", (unsigned long)_flashLog.pendingCount());
+
+    FlashLogRecord records[FLASH_LOG_BATCH];
+    uint32_t openDay = UINT32_MAX;
+    File dataFile;
+    bool success = true;
+    uint16_t found;
+    while ((found = _flashLog.peek(records, FLASH_LOG_BATCH)) > 0)
+    {
+        // Each write covers a single day file
+        uint32_t day = records[0].timestamp / 86400;
+        if (day != openDay)
+        {
+            if (dataFile)
+            {
+                dataFile.close();
+            }
+            String filename = getFilename(DateTime(records[0].timestamp));
+            if (!SD.exists(filename) && !createFile(filename))
+            {
+                recordError(HEALTH_SD_OPEN_FAIL);
+                success = false;
+                break;
+            }
+            dataFile = SD.open(filename, FILE_APPEND);
+            if (!dataFile)
+            {
+                Serial.println("Failed to open file for migration: " + filename);
+                recordError(HEALTH_SD_OPEN_FAIL);
+                success = false;
+                break;
+            }
+            openDay = day;
+        }
+
+        String batch = "";
+        batch.reserve(found * 32);
+        uint16_t used = 0;
+        while (used < found && records[used].timestamp / 86400 == day)
+        {
+            batch += formatRow(DateTime(records[used].timestamp), records[used].voltage, records[used].count);
+            batch += "\r\n";
+            used++;
+        }
+
+        if (dataFile.print(batch) != batch.length())
+        {
+            recordError(HEALTH_SD_WRITE_FAIL);
+            success = false;
+            break;
+        }
+        dataFile.flush();
+
+        // Records are only released once they are on the card
+        if (!_flashLog.consume(used))
+        {
+            recordError(HEALTH_FLASH_FAIL);
+            success = false;
+            break;
+        }
+    }
+    if (dataFile)
+    {
+        dataFile.close();
+    }
+
+    if (!success)
+    {
+        Serial.println("Failed to migrate staged records");
+        _hasMigrationFailed = true;
+        handleSDError();
+        return false;
+    }
+    _hasMigrationFailed = false;
+    _lastMigrationDay = currentTime().unixtime() / 86400;
+    return true;
+}
+
+bool KepecsWheelBase::createFile(String filename)
 {
     // Ensure filename starts with a forward slash
     if (!filename.startsWith("/"))
@@ -238,27 +528,48 @@ bool KepecsWheel::createFile(String filename)
     return false;
 }
 
-void KepecsWheel::adjustRTC(uint32_t timestamp)
+bool KepecsWheelBase::prepareSync()
 {
-    _rtc.adjustRTC(timestamp);
+    // Everything is written before the transfer so Hublink never sends a file
+    // that is still being appended to
+    uint32_t start = millis();
+    if (!ensureSD())
+    {
+        return false;
+    }
+    bool success = migrateToSD();
+    success = flushRollups() && success;
+    success = flushHealth(true) && success;
+    Serial.printf("Sync prepared in %lu ms\n", (unsigned long)(millis() - start));
+    return success;
+}
+
+void KepecsWheelBase::benchmarkSD()
+{
+    if (!_isSDInitialized)
+    {
+        Serial.println("SD Card not initialized, skipping benchmark");
+        return;
+    }
+    _sd.benchmark();
 }
 
-void KepecsWheel::resetLogCount()
+void KepecsWheelBase::resetLogCount()
 {
     _logCount = 0;
 }
 
-void KepecsWheel::incrementLogCount()
+void KepecsWheelBase::incrementLogCount()
 {
     _logCount++;
 }
 
-uint32_t KepecsWheel::getLogCount()
+uint32_t KepecsWheelBase::getLogCount()
 {
     return _logCount;
 }
 
-bool KepecsWheel::shouldSync(int sleepSeconds, int syncMinutes)
+bool KepecsWheelBase::shouldSync(int sleepSeconds, int syncMinutes)
 {
     // Convert everything to minutes for comparison
     float elapsedMinutes = (float)(sleepSeconds * _logCount) / 60.0;
@@ -271,12 +582,12 @@ bool KepecsWheel::shouldSync(int sleepSeconds, int syncMinutes)
     return shouldSync;
 }
 
-float KepecsWheel::getBatteryVoltage()
+float KepecsWheelBase::getBatteryVoltage()
 {
     return _batteryMonitor.cellVoltage();
 }
 
-float KepecsWheel::getBatteryPercent()
+float KepecsWheelBase::getBatteryPercent()
 {
     return _batteryMonitor.cellPercent();
 }
\ No newline at end of file
@@ -7,48 +7,130 @@
 #include <RTClib.h>
 #include "ULPManager.h"
 #include "RTCManager.h"
+#include "SDManager.h"
+#include "FlashLog.h"
+#include "PartitionStorage.h"
+#include "RollupManager.h"
+#include "HealthManager.h"
 #include "Preferences.h"
 #include "Adafruit_MAX1704X.h"
 #include "SharedDefs.h"
+#include "Boards.h"
 
 #define LED_BUILTIN 13 // Built-in LED pin
 extern uint8_t SD_CS;  // Make SD_CS accessible to sketches
 
-class KepecsWheel
+#define FLASH_LOG_MIGRATE_PERCENT 75 // Migrate early once the staging log is this full
+#define FLASH_LOG_BATCH 128          // Records moved to SD per write
+#define FLASH_LOG_RETRY_SECONDS 3600 // Wait after a failed migration; syncs still retry
+
+// Board-independent logger; the RTC is supplied by KepecsWheelT or KepecsWheel
+class KepecsWheelBase
 {
 public:
-    KepecsWheel(uint8_t wheelType = 2); // Default to DS3231 (type 2)
-    bool begin();
-    bool logData();
     void sleep(int seconds);
-    void adjustRTC(uint32_t timestamp);
     bool shouldSync(int sleepSeconds, int syncMinutes);
     uint32_t getLogCount();
     bool reinit();
+    bool isWakeFromSleep() const { return _isWakeFromSleep; }
     uint8_t getSDCSPin() const { return _sdCSPin; } // Getter for SD_CS pin
+    uint32_t getSDFrequency() const { return _sd.getFrequency(); }
+    void benchmarkSD();
+    void setStorageMode(StorageMode mode) { _storageMode = mode; } // Call before begin()
+    StorageMode getStorageMode() const { return _storageMode; }
+    bool migrateToSD();
+
+    bool prepareSync(); // Migrate staged rows and write summary and health rows before a Hublink sync
+
+    uint8_t getLastError() const { return _lastError; } // HealthCounter from the last begin()/logData(), HEALTH_NO_ERROR if none
+
+protected:
+    KepecsWheelBase(uint8_t sdCSPin, gpio_num_t sensorPin);
+    void beginStorage();                                        // Wake reason, I2C, flash and SD
+    bool finishBegin(bool isRTCInitialized, bool rtcLostPower); // Battery monitor and status
+    bool canLog();
+    bool logDataAt(const DateTime &now);
+    virtual DateTime currentTime() = 0; // RTC time from the board wrapper
 
 private:
     const char *CSV_HEADER = "datetime,battery_voltage,count";
-    String getCurrentFilename();
+    String getFilename(const DateTime &dt);
+    String formatRow(const DateTime &dt, float voltage, int count);
+    bool ensureSD();
+    void handleSDError(); // Step down the SD clock and remount
+    void recordError(HealthCounter counter);
+    bool flushRollups();
+    bool flushHealth(bool force);
     bool createFile(String filename);
     void resetLogCount();
     void incrementLogCount();
-    void updateSDCSPin();
 
-    RTC_DATA_ATTR static uint32_t _logCount; // Persists in RTC memory
+    RTC_DATA_ATTR static uint32_t _logCount;             // Persists in RTC memory
+    RTC_DATA_ATTR static uint32_t _lastMigrationDay;     // Days since 1970 of last flash migration
+    RTC_DATA_ATTR static uint32_t _lastMigrationAttempt; // Unix time of the last scheduled attempt
+    RTC_DATA_ATTR static bool _hasMigrationFailed;       // Back off until FLASH_LOG_RETRY_SECONDS pass
     ULPManager _ulp;
     bool _isWakeFromSleep;
-    RTCManager _rtc;
+    SDManager _sd;
+    StorageMode _storageMode = StorageMode::SD_DIRECT;
+    PartitionStorage _flashStorage;
+    FlashLog _flashLog;
+    RollupManager _rollup;
+    HealthManager _health;
+    uint8_t _lastError = HEALTH_NO_ERROR;
     bool _isRTCInitialized;
     bool _isSDInitialized;
+    bool _hasSDMountFailed = false; // Mount already failed this wake
     bool allInitialized;
     bool _beginFailed = false;
     Adafruit_MAX17048 _batteryMonitor;
-    RTCType _rtcType;
-    uint8_t _sdCSPin = 10; // Default to 10, will be updated based on RTC type
+    uint8_t _sdCSPin;
     float getBatteryVoltage();
     float getBatteryPercent();
     bool _isBatteryMonitorInitialized;
 };
 
-#endif // KEPECS_WHEEL_H
\ No newline at end of file
+// Board resolved at compile time, e.g. KepecsWheelT<BoardDS3231> wheel;
+template <typename Board>
+class KepecsWheelT : public KepecsWheelBase
+{
+public:
+    KepecsWheelT() : KepecsWheelBase(Board::sdCSPin(), Board::sensorPin()) {}
+
+    bool begin()
+    {
+        beginStorage();
+        Serial.printf("  RTC: Initializing %s\n", Board::name());
+        bool isRTCInitialized = _rtc.begin();
+        return finishBegin(isRTCInitialized, _rtc.lostPower());
+    }
+
+    bool logData() { return canLog() && logDataAt(_rtc.now()); }
+    void adjustRTC(uint32_t timestamp) { _rtc.adjustRTC(timestamp); }
+
+protected:
+    DateTime currentTime() override { return _rtc.now(); }
+
+private:
+    RTCManager<typename Board::RTCDriver> _rtc;
+};
+
+// Board chosen at runtime from the wheel type, kept for existing sketches
+class KepecsWheel : public KepecsWheelBase
+{
+public:
+    KepecsWheel(uint8_t wheelType = 2); // Default to DS3231 (type 2)
+    bool begin();
+    bool logData();
+    void adjustRTC(uint32_t timestamp);
+
+protected:
+    DateTime currentTime() override;
+
+private:
+    RTCType _rtcType;
+    RTCManager<BoardDS3231::RTCDriver> _ds3231;
+    RTCManager<BoardPCF8523::RTCDriver> _pcf8523;
+};
+
+#endif // KEPECS_WHEEL_H
@@ -0,0 +1,36 @@
+#include "PartitionStorage.h"
+
+PartitionStorage::PartitionStorage() : _partition(nullptr)
+{
+}
+
+bool PartitionStorage::begin(const char *label)
+{
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!_partition)
+    {
+        Serial.printf("  Flash: partition '%s' not found\n", label);
+        return false;
+    }
+    return true;
+}
+
+uint32_t PartitionStorage::size()
+{
+    return _partition ? _partition->size : 0;
+}
+
+bool PartitionStorage::read(uint32_t offset, void *data, size_t length)
+{
+    return _partition && esp_partition_read(_partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionStorage::write(uint32_t offset, const void *data, size_t length)
+{
+    return _partition && esp_partition_write(_partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionStorage::eraseSector(uint32_t offset)
+{
+    return _partition && esp_partition_erase_range(_partition, offset, FLASH_LOG_SECTOR_SIZE) == ESP_OK;
+}
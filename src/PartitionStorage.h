@@ -0,0 +1,26 @@
+#ifndef PARTITION_STORAGE_H
+#define PARTITION_STORAGE_H
+
+#include <Arduino.h>
+#include "esp_partition.h"
+#include "FlashLog.h"
+
+#define FLASH_LOG_PARTITION "spiffs" // Raw data partition used for the staging log
+
+// FlashLogStorage backed by an internal flash data partition
+class PartitionStorage : public FlashLogStorage
+{
+public:
+    PartitionStorage();
+    bool begin(const char *label = FLASH_LOG_PARTITION);
+
+    uint32_t size() override;
+    bool read(uint32_t offset, void *data, size_t length) override;
+    bool write(uint32_t offset, const void *data, size_t length) override;
+    bool eraseSector(uint32_t offset) override;
+
+private:
+    const esp_partition_t *_partition;
+};
+
+#endif // PARTITION_STORAGE_H
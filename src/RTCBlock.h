@@ -0,0 +1,51 @@
+#ifndef RTC_BLOCK_H
+#define RTC_BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Validation for structs kept in RTC_NOINIT_ATTR memory, which holds garbage
+// after power loss. A block starts with a uint32_t magic and ends with a
+// uint32_t checksum covering everything before it.
+namespace RTCBlock
+{
+    inline uint32_t fnv1a(const void *data, size_t length)
+    {
+        const uint8_t *bytes = (const uint8_t *)data;
+        uint32_t hash = 2166136261UL;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619UL;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    uint32_t checksum(const T &block)
+    {
+        return fnv1a(&block, offsetof(T, checksum));
+    }
+
+    template <typename T>
+    bool isValid(const T &block, uint32_t magic)
+    {
+        return block.magic == magic && block.checksum == checksum(block);
+    }
+
+    template <typename T>
+    void seal(T &block)
+    {
+        block.checksum = checksum(block);
+    }
+
+    // Zero the block and stamp it; the caller seals after setting any defaults
+    template <typename T>
+    void reset(T &block, uint32_t magic)
+    {
+        memset(&block, 0, sizeof(block));
+        block.magic = magic;
+    }
+}
+
+#endif // RTC_BLOCK_H
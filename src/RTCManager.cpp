@@ -1,282 +1,105 @@
 #include "RTCManager.h"
 
-const char *RTCManager::_daysOfWeek[] = {
-    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
-
-RTCManager::RTCManager() : _pcf8523(nullptr), _ds3231(nullptr), _isInitialized(false), _rtcType(RTCType::UNKNOWN)
-{
-}
-
-RTCManager::~RTCManager()
-{
-    delete _pcf8523;
-    delete _ds3231;
-}
-
-bool RTCManager::begin(RTCType type)
-{
-    _rtcType = type;
-    bool success = false;
-
-    // Clean up any existing instances
-    delete _pcf8523;
-    delete _ds3231;
-    _pcf8523 = nullptr;
-    _ds3231 = nullptr;
-
-    switch (type)
-    {
-    case RTCType::PCF8523:
-        _pcf8523 = new RTC_PCF8523();
-        success = _pcf8523->begin();
-        break;
-    case RTCType::DS3231:
-        _ds3231 = new RTC_DS3231();
-        success = _ds3231->begin();
-        break;
-    default:
-        Serial.println("Unknown RTC type");
-        return false;
-    }
-
-    if (!success)
-    {
-        Serial.println("Couldn't find RTC");
-        return false;
-    }
-
-    if (!_preferences.begin(PREFS_NAMESPACE, false))
-    {
-        Serial.println("Failed to initialize preferences");
-        return false;
-    }
+// Seconds since 1970 of this build, evaluated by the compiler
+static constexpr uint32_t BUILD_TIMESTAMP = BuildStamp::timestamp(__DATE__, __TIME__);
 
-    // Only check for new compilation on hard reset
-    esp_reset_reason_t reset_reason = esp_reset_reason();
-    bool isWakeFromSleep = (reset_reason == ESP_SLEEP_WAKEUP_TIMER);
+// Initialize static members
+RTC_NOINIT_ATTR uint32_t RTCManagerBase::_cachedBuild;
+RTC_NOINIT_ATTR uint32_t RTCManagerBase::_cachedBuildCheck;
 
-    if (!isWakeFromSleep && isNewCompilation())
-    {
-        updateRTC();
-        updateCompilationID();
-    }
-    else if ((type == RTCType::PCF8523 && _pcf8523->lostPower()) ||
-             (type == RTCType::DS3231 && _ds3231->lostPower()))
-    {
-        Serial.println("RTC lost power, updating time from compilation");
-        updateRTC();
-    }
-
-    _isInitialized = true;
-    _preferences.end();
-    return true;
-}
-
-DateTime RTCManager::now()
-{
-    if (!_isInitialized)
-    {
-        return DateTime(DEFAULT_TIMESTAMP);
-    }
-    switch (_rtcType)
-    {
-    case RTCType::PCF8523:
-        return _pcf8523->now();
-    case RTCType::DS3231:
-        return _ds3231->now();
-    default:
-        return DateTime(DEFAULT_TIMESTAMP);
-    }
-}
-
-void RTCManager::serialPrintDateTime()
-{
-    DateTime current = now();
-    Serial.printf("%04d-%02d-%02d %02d:%02d:%02d",
-                  current.year(), current.month(), current.day(),
-                  current.hour(), current.minute(), current.second());
-}
-
-void RTCManager::adjustRTC(uint32_t timestamp)
-{
-    DateTime dt(timestamp);
-    adjustRTC(dt);
-}
+const char *RTCManagerBase::_daysOfWeek[] = {
+    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
 
-void RTCManager::adjustRTC(const DateTime &dt)
+String RTCManagerBase::formatDateTime(const DateTime &dt)
 {
-    switch (_rtcType)
-    {
-    case RTCType::PCF8523:
-        if (_pcf8523)
-            _pcf8523->adjust(dt);
-        break;
-    case RTCType::DS3231:
-        if (_ds3231)
-            _ds3231->adjust(dt);
-        break;
-    }
+    char timeStr[20];
+    snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
+             dt.year(), dt.month(), dt.day(),
+             dt.hour(), dt.minute(), dt.second());
+    return String(timeStr);
 }
 
-String RTCManager::getDayOfWeek()
+String RTCManagerBase::getCompileDateTime()
 {
-    return String(_daysOfWeek[now().dayOfTheWeek()]);
+    return formatDateTime(DateTime(BUILD_TIMESTAMP));
 }
 
-uint32_t RTCManager::getUnixTime()
+DateTime RTCManagerBase::getCompensatedDateTime()
 {
-    return now().unixtime();
+    // Add upload delay compensation
+    return DateTime(BUILD_TIMESTAMP + UPLOAD_DELAY_SECONDS);
 }
 
-DateTime RTCManager::getFutureTime(int days, int hours, int minutes, int seconds)
+bool RTCManagerBase::isCachedBuild()
 {
-    if (!_isInitialized)
-    {
-        return DateTime(DEFAULT_TIMESTAMP);
-    }
-    TimeSpan span(days, hours, minutes, seconds);
-    return now() + span;
+    return _cachedBuild == BUILD_TIMESTAMP && _cachedBuildCheck == ~BUILD_TIMESTAMP;
 }
 
-String RTCManager::getCompileDateTime()
+void RTCManagerBase::cacheBuild()
 {
-    // Use compiler macros for build time
-    const char *compileDate = __DATE__; // Format: "Mmm dd yyyy"
-    const char *compileTime = __TIME__; // Format: "hh:mm:ss"
-
-    // Parse date components
-    char month[4];
-    int day, year;
-    sscanf(compileDate, "%s %d %d", month, &day, &year);
-
-    // Convert month string to number
-    int monthNum = 1;
-    const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    for (int i = 0; i < 12; i++)
-    {
-        if (strncmp(month, months[i], 3) == 0)
-        {
-            monthNum = i + 1;
-            break;
-        }
-    }
-
-    // Parse time components
-    int hour, minute, second;
-    sscanf(compileTime, "%d:%d:%d", &hour, &minute, &second);
-
-    char compileDateTime[32];
-    // Format with just the compile date and time
-    snprintf(compileDateTime, sizeof(compileDateTime),
-             "%04d-%02d-%02d %02d:%02d:%02d",
-             year, monthNum, day,
-             hour, minute, second);
-
-    return String(compileDateTime);
+    _cachedBuild = BUILD_TIMESTAMP;
+    _cachedBuildCheck = ~BUILD_TIMESTAMP;
 }
 
-DateTime RTCManager::getCompensatedDateTime()
+bool RTCManagerBase::isNewCompilation()
 {
-    // Parse the compile time directly
-    const char *compileDate = __DATE__; // Format: "Mmm dd yyyy"
-    const char *compileTime = __TIME__; // Format: "hh:mm:ss"
-
-    // Parse date components
-    char month[4];
-    int day, year;
-    sscanf(compileDate, "%s %d %d", month, &day, &year);
-
-    // Convert month string to number
-    int monthNum = 1;
-    const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    for (int i = 0; i < 12; i++)
+    // Resets after the first boot of this build never touch NVS
+    if (isCachedBuild())
     {
-        if (strncmp(month, months[i], 3) == 0)
-        {
-            monthNum = i + 1;
-            break;
-        }
+        return false;
     }
 
-    // Parse time components
-    int hour, minute, second;
-    sscanf(compileTime, "%d:%d:%d", &hour, &minute, &second);
-
-    // Create DateTime object from compile time
-    DateTime compileDateTime(year, monthNum, day, hour, minute, second);
-
-    // Add upload delay compensation
-    return compileDateTime + TimeSpan(0, 0, 0, UPLOAD_DELAY_SECONDS);
-}
-
-bool RTCManager::isNewCompilation()
-{
-    _preferences.begin(PREFS_NAMESPACE, false);
-    const String currentBuildTime = getCompileDateTime();
-    String storedBuildTime = _preferences.getString("buildTime", "");
+    _preferences.begin(PREFS_NAMESPACE, true);
+    uint32_t storedBuild = _preferences.getUInt("buildStamp", 0);
+    _preferences.end();
 
-    // Store new build time
-    if (currentBuildTime != storedBuildTime)
+    bool isNew = storedBuild != BUILD_TIMESTAMP;
+    if (!isNew)
     {
-        _preferences.putString("buildTime", currentBuildTime);
+        cacheBuild();
     }
-    _preferences.end();
 
     Serial.println("\nChecking build status:");
     Serial.println("---------------------------");
-    Serial.println("Current build ID:  " + currentBuildTime);
-    Serial.println("Previous build ID: " + storedBuildTime);
-    Serial.println("Is new upload:     " + String(currentBuildTime != storedBuildTime));
+    Serial.printf("Current build ID:  %lu\n", (unsigned long)BUILD_TIMESTAMP);
+    Serial.printf("Previous build ID: %lu\n", (unsigned long)storedBuild);
+    Serial.println("Is new upload:     " + String(isNew));
     Serial.println("---------------------------\n");
 
-    return currentBuildTime != storedBuildTime;
+    return isNew;
 }
 
-void RTCManager::updateCompilationID()
+void RTCManagerBase::updateCompilationID()
 {
+    if (isCachedBuild())
+    {
+        return;
+    }
+
     _preferences.begin(PREFS_NAMESPACE, false);
-    const String currentCompileTime = getCompileDateTime();
 
     Serial.println("\nUpdating compilation ID:");
     Serial.println("----------------------");
-    Serial.println("Storing new compile time: " + currentCompileTime);
+    Serial.println("Storing new compile time: " + getCompileDateTime());
 
-    _preferences.putString("compileTime", currentCompileTime.c_str());
+    // Only write when the build actually changed
+    if (_preferences.getUInt("buildStamp", 0) != BUILD_TIMESTAMP)
+    {
+        _preferences.putUInt("buildStamp", BUILD_TIMESTAMP);
+
+        // Drop the string keys used by earlier versions
+        _preferences.remove("buildTime");
+        _preferences.remove("compileTime");
+    }
 
     // Verify storage
-    String verifyTime = _preferences.getString("compileTime", "");
-    Serial.println("Verified stored time:    " + verifyTime);
-    Serial.println("Storage successful:      " + String(verifyTime == currentCompileTime));
+    bool stored = _preferences.getUInt("buildStamp", 0) == BUILD_TIMESTAMP;
+    Serial.println("Storage successful:      " + String(stored));
     Serial.println("----------------------\n");
 
     _preferences.end();
+    if (stored)
+    {
+        cacheBuild();
+    }
 }
-
-void RTCManager::updateRTC()
-{
-    Serial.println("\nUpdating RTC time:");
-    Serial.println("----------------");
-    Serial.println("Compile time: " + getCompileDateTime());
-
-    // Get compensated DateTime
-    DateTime compensatedTime = getCompensatedDateTime();
-
-    // Format and print the compensation information
-    char timeStr[20];
-    snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
-             compensatedTime.year(), compensatedTime.month(), compensatedTime.day(),
-             compensatedTime.hour(), compensatedTime.minute(), compensatedTime.second());
-    Serial.println("Compensated time: " + String(timeStr));
-
-    // Update RTC with compensated time
-    adjustRTC(compensatedTime);
-
-    // Verify the time was set correctly
-    DateTime currentTime = now();
-    char currentTimeStr[20];
-    snprintf(currentTimeStr, sizeof(currentTimeStr), "%04d-%02d-%02d %02d:%02d:%02d",
-             currentTime.year(), currentTime.month(), currentTime.day(),
-             currentTime.hour(), currentTime.minute(), currentTime.second());
-    Serial.println("Verified time: " + String(currentTimeStr));
-    Serial.println("----------------\n");
-}
\ No newline at end of file
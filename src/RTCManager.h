@@ -5,47 +5,123 @@
 #include <RTClib.h>
 #include <Preferences.h>
 #include "SharedDefs.h"
+#include "BuildStamp.h"
 
 #define UPLOAD_DELAY_SECONDS 30 // Compensation for delay between compilation and upload
 
-class RTCManager
+// Chip-independent build stamp and NVS bookkeeping
+class RTCManagerBase
 {
 public:
-    RTCManager();
-    ~RTCManager(); // Add destructor to clean up
-    bool begin(RTCType type);
-
-    // Basic RTC functions
-    DateTime now();
-    void serialPrintDateTime();
-
-    // Time adjustment functions
-    void adjustRTC(uint32_t timestamp);
-    void adjustRTC(const DateTime &dt);
-
     // Compilation time management
     bool isNewCompilation();
     void updateCompilationID();
+    bool lostPower() const { return _lostPower; } // RTC reported power loss during begin()
 
-    // Helper functions
-    String getDayOfWeek();
-    uint32_t getUnixTime();
-    DateTime getFutureTime(int days, int hours, int minutes, int seconds);
-
-private:
-    RTC_PCF8523 *_pcf8523;
-    RTC_DS3231 *_ds3231;
-    RTCType _rtcType;
+protected:
     Preferences _preferences;
-    bool _isInitialized;
+    bool _isInitialized = false;
+    bool _lostPower = false;
 
-    void updateRTC();
     String getCompileDateTime();
     DateTime getCompensatedDateTime();
+    static String formatDateTime(const DateTime &dt);
+    static bool isCachedBuild();
+    static void cacheBuild();
     static const char *_daysOfWeek[7];
 
+    // Build identity cache, kept across software, watchdog and brownout resets
+    RTC_NOINIT_ATTR static uint32_t _cachedBuild;
+    RTC_NOINIT_ATTR static uint32_t _cachedBuildCheck; // Complement of _cachedBuild when valid
+
     // Default time constants
     static const uint32_t DEFAULT_TIMESTAMP = SECONDS_FROM_1970_TO_2000;
 };
 
-#endif
\ No newline at end of file
+// RTC access for one chip, held by value so no heap allocation or dispatch
+template <typename Driver>
+class RTCManager : public RTCManagerBase
+{
+public:
+    bool begin();
+
+    // Basic RTC functions
+    DateTime now() { return _isInitialized ? _driver.now() : DateTime(DEFAULT_TIMESTAMP); }
+    void serialPrintDateTime() { Serial.print(formatDateTime(now())); }
+
+    // Time adjustment functions
+    void adjustRTC(uint32_t timestamp) { adjustRTC(DateTime(timestamp)); }
+    void adjustRTC(const DateTime &dt) { _driver.adjust(dt); }
+
+    // Helper functions
+    String getDayOfWeek() { return String(_daysOfWeek[now().dayOfTheWeek()]); }
+    uint32_t getUnixTime() { return now().unixtime(); }
+    DateTime getFutureTime(int days, int hours, int minutes, int seconds);
+
+private:
+    Driver _driver;
+
+    void updateRTC();
+};
+
+template <typename Driver>
+bool RTCManager<Driver>::begin()
+{
+    if (!_driver.begin())
+    {
+        Serial.println("Couldn't find RTC");
+        return false;
+    }
+
+    // Only check for new compilation on hard reset
+    esp_reset_reason_t reset_reason = esp_reset_reason();
+    bool isWakeFromSleep = (reset_reason == ESP_RST_DEEPSLEEP);
+
+    // Read before the build check so power loss is recorded on a new build too
+    _lostPower = _driver.lostPower();
+    if (!isWakeFromSleep && isNewCompilation())
+    {
+        updateRTC();
+        updateCompilationID();
+    }
+    else if (_lostPower)
+    {
+        Serial.println("RTC lost power, updating time from compilation");
+        updateRTC();
+    }
+
+    _isInitialized = true;
+    return true;
+}
+
+template <typename Driver>
+DateTime RTCManager<Driver>::getFutureTime(int days, int hours, int minutes, int seconds)
+{
+    if (!_isInitialized)
+    {
+        return DateTime(DEFAULT_TIMESTAMP);
+    }
+    TimeSpan span(days, hours, minutes, seconds);
+    return now() + span;
+}
+
+template <typename Driver>
+void RTCManager<Driver>::updateRTC()
+{
+    Serial.println("\nUpdating RTC time:");
+    Serial.println("----------------");
+    Serial.println("Compile time: " + getCompileDateTime());
+
+    // Get compensated DateTime
+    DateTime compensatedTime = getCompensatedDateTime();
+    Serial.println("Compensated time: " + formatDateTime(compensatedTime));
+
+    // Update RTC with compensated time
+    adjustRTC(compensatedTime);
+
+    // Verify the time was set correctly
+    Serial.println("Verified time: " + formatDateTime(_driver.now()));
+    Serial.println("----------------\n");
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "RollupManager.h"
+#include <RTClib.h>
+
+// Initialize static members
+RTC_NOINIT_ATTR RollupState RollupManager::_state;
+
+void RollupManager::begin()
+{
+    if (RTCBlock::isValid(_state, ROLLUP_MAGIC) && _state.pendingCount <= ROLLUP_PENDING_MAX)
+    {
+        return;
+    }
+    RTCBlock::reset(_state, ROLLUP_MAGIC);
+    seal();
+}
+
+void RollupManager::update(uint32_t timestamp, float voltage, uint16_t count)
+{
+    uint32_t hourStart = timestamp - timestamp % 3600;
+    uint32_t dayStart = timestamp - timestamp % 86400;
+
+    if (_state.hour.bins > 0 && _state.hour.start != hourStart)
+    {
+        close(_state.hour);
+    }
+    if (_state.day.bins > 0 && _state.day.start != dayStart)
+    {
+        close(_state.day);
+    }
+
+    accumulate(_state.hour, ROLLUP_HOUR, hourStart, voltage, count);
+    accumulate(_state.day, ROLLUP_DAY, dayStart, voltage, count);
+    seal();
+}
+
+void RollupManager::accumulate(RollupBucket &bucket, RollupPeriod period, uint32_t start, float voltage, uint16_t count)
+{
+    if (bucket.bins == 0)
+    {
+        bucket = {};
+        bucket.start = start;
+        bucket.period = period;
+        bucket.minVoltage = voltage;
+        bucket.maxVoltage = voltage;
+    }
+
+    bucket.count += count;
+    bucket.bins++;
+    if (count > 0)
+    {
+        bucket.activeBins++;
+    }
+    bucket.maxBin = max(bucket.maxBin, count);
+    bucket.minVoltage = min(bucket.minVoltage, voltage);
+    bucket.maxVoltage = max(bucket.maxVoltage, voltage);
+}
+
+void RollupManager::close(RollupBucket &bucket)
+{
+    if (_state.pendingCount == ROLLUP_PENDING_MAX)
+    {
+        // Drop the oldest period rather than the newest
+        memmove(&_state.pending[0], &_state.pending[1], sizeof(RollupBucket) * (ROLLUP_PENDING_MAX - 1));
+        _state.pendingCount--;
+    }
+    _state.pending[_state.pendingCount++] = bucket;
+    bucket.bins = 0;
+}
+
+bool RollupManager::flush()
+{
+    String openFilename = "";
+    File file;
+    uint8_t written = 0;
+
+    while (written < _state.pendingCount)
+    {
+        String filename = getFilename(_state.pending[written].start);
+        if (filename != openFilename)
+        {
+            if (file)
+            {
+                file.close();
+            }
+            bool isNew = !SD.exists(filename);
+            file = SD.open(filename, FILE_APPEND);
+            if (!file)
+            {
+                Serial.println("Failed to open summary file: " + filename);
+                break;
+            }
+            if (isNew && !file.println(ROLLUP_HEADER))
+            {
+                break;
+            }
+            openFilename = filename;
+        }
+        if (!file.println(formatRow(_state.pending[written])))
+        {
+            break;
+        }
+        written++;
+    }
+    if (file)
+    {
+        file.close();
+    }
+
+    // Keep anything that did not make it to the card
+    memmove(&_state.pending[0], &_state.pending[written], sizeof(RollupBucket) * (_state.pendingCount - written));
+    _state.pendingCount -= written;
+    seal();
+    return _state.pendingCount == 0;
+}
+
+String RollupManager::getFilename(uint32_t timestamp)
+{
+    DateTime dt(timestamp);
+    char filename[24];
+    snprintf(filename, sizeof(filename), "/SUMMARY_%04d%02d.csv", dt.year(), dt.month());
+    return String(filename);
+}
+
+String RollupManager::formatRow(const RollupBucket &bucket)
+{
+    DateTime dt(bucket.start);
+    char row[96];
+    snprintf(row, sizeof(row), "%s,%04d-%02d-%02d %02d:%02d:%02d,%lu,%u,%u,%u,%.2f,%.2f",
+             (bucket.period == ROLLUP_DAY) ? "day" : "hour",
+             dt.year(), dt.month(), dt.day(),
+             dt.hour(), dt.minute(), dt.second(),
+             (unsigned long)bucket.count, bucket.bins, bucket.activeBins, bucket.maxBin,
+             bucket.minVoltage, bucket.maxVoltage);
+    return String(row);
+}
@@ -0,0 +1,64 @@
+#ifndef ROLLUP_MANAGER_H
+#define ROLLUP_MANAGER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "SharedDefs.h"
+#include "RTCBlock.h"
+
+#define ROLLUP_MAGIC 0x524F4C4C // "ROLL"
+#define ROLLUP_PENDING_MAX 48   // Closed periods held in RTC memory until SD is available
+#define ROLLUP_HEADER "period,start,count,bins,active_bins,max_bin,min_voltage,max_voltage"
+
+enum RollupPeriod : uint8_t
+{
+    ROLLUP_HOUR,
+    ROLLUP_DAY
+};
+
+// Running aggregate for one hour or one day
+struct RollupBucket
+{
+    uint32_t start;      // Unix time the period began
+    uint32_t count;      // Sum of logged counts
+    uint16_t bins;       // Rows logged, 0 when the bucket is empty
+    uint16_t activeBins; // Rows with a non-zero count
+    uint16_t maxBin;
+    uint8_t period;
+    uint8_t reserved;
+    float minVoltage;
+    float maxVoltage;
+};
+
+// Kept in no-init RTC memory so open and unflushed periods survive
+// brownout, watchdog and panic resets as well as deep sleep
+struct RollupState
+{
+    uint32_t magic;
+    RollupBucket hour;
+    RollupBucket day;
+    RollupBucket pending[ROLLUP_PENDING_MAX];
+    uint8_t pendingCount;
+    uint8_t reserved[3];
+    uint32_t checksum;
+};
+
+class RollupManager
+{
+public:
+    void begin(); // Validate RTC state, reset only on power loss or corruption
+    void update(uint32_t timestamp, float voltage, uint16_t count);
+    bool flush(); // Append closed periods to SUMMARY_YYYYMM.csv, SD must be mounted
+    uint8_t pendingCount() const { return _state.pendingCount; }
+
+private:
+    void accumulate(RollupBucket &bucket, RollupPeriod period, uint32_t start, float voltage, uint16_t count);
+    void close(RollupBucket &bucket);
+    String getFilename(uint32_t timestamp);
+    String formatRow(const RollupBucket &bucket);
+    void seal() { RTCBlock::seal(_state); }
+
+    RTC_NOINIT_ATTR static RollupState _state; // Updated once per wake
+};
+
+#endif // ROLLUP_MANAGER_H
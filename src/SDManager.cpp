@@ -0,0 +1,255 @@
+#include "SDManager.h"
+
+// Initialize static members
+RTC_DATA_ATTR SDProfile SDManager::_profile = {0, 0, 0, 0, 0};
+RTC_DATA_ATTR bool SDManager::_probeFailed = false;
+
+// SPI clock ladder, fastest first; 1 MHz is the historical fixed clock
+const uint32_t SDManager::_frequencies[] = {
+    25000000, 20000000, 16000000, 10000000, 8000000, 4000000, 1000000};
+const uint8_t SDManager::NUM_FREQUENCIES = sizeof(_frequencies) / sizeof(_frequencies[0]);
+
+SDManager::SDManager() : _csPin(10)
+{
+}
+
+bool SDManager::begin(uint8_t csPin, bool isWakeFromSleep)
+{
+    _csPin = csPin;
+    SPI.begin(SCK, MISO, MOSI, _csPin);
+
+    // Cold boot always renegotiates in case the card was swapped
+    if (isWakeFromSleep)
+    {
+        if (_probeFailed)
+        {
+            // No clock worked last time, so make one attempt per wake until the next cold boot
+            uint32_t lowest = _frequencies[NUM_FREQUENCIES - 1];
+            if (!mount(lowest))
+            {
+                SD.end();
+                Serial.println("  SD: still unavailable, skipping renegotiation");
+                return false;
+            }
+            Serial.printf("  SD: recovered at %lu Hz\n", (unsigned long)lowest);
+            remember(lowest);
+            return true;
+        }
+        if (!isValid(_profile))
+        {
+            loadProfile();
+        }
+        if (isValid(_profile))
+        {
+            if (mount(_profile.frequency))
+            {
+                Serial.printf("  SD: mounted at cached %lu Hz\n", (unsigned long)_profile.frequency);
+                return true;
+            }
+            // Step down from the clock that just failed
+            Serial.printf("  SD: cached %lu Hz failed, renegotiating\n", (unsigned long)_profile.frequency);
+            return probe(frequencyIndex(_profile.frequency) + 1);
+        }
+    }
+    return probe(0);
+}
+
+bool SDManager::handleIOError()
+{
+    int index = frequencyIndex(_profile.frequency);
+    if (index < 0)
+    {
+        return probe(0);
+    }
+    if (index + 1 >= NUM_FREQUENCIES)
+    {
+        // Already at the floor, just remount
+        Serial.println("  SD: I/O error at lowest clock, remounting");
+        return mount(_profile.frequency);
+    }
+    Serial.printf("  SD: I/O error at %lu Hz, falling back\n", (unsigned long)_profile.frequency);
+    return probe(index + 1);
+}
+
+bool SDManager::probe(uint8_t startIndex)
+{
+    for (uint8_t i = startIndex; i < NUM_FREQUENCIES; i++)
+    {
+        if (mount(_frequencies[i]) && verify())
+        {
+            remember(_frequencies[i]);
+            Serial.printf("  SD: negotiated %lu Hz (type %d, sector %d)\n",
+                          (unsigned long)_profile.frequency, _profile.cardType, _profile.sectorSize);
+            return true;
+        }
+        Serial.printf("  SD: %lu Hz unstable\n", (unsigned long)_frequencies[i]);
+    }
+
+    // Keep the cached profile; wakes retry once at the floor instead of probing again
+    SD.end();
+    _probeFailed = true;
+    return false;
+}
+
+void SDManager::remember(uint32_t frequency)
+{
+    _probeFailed = false;
+    _profile.magic = SD_PROFILE_MAGIC;
+    _profile.frequency = frequency;
+    _profile.sectorSize = (uint16_t)SD.sectorSize();
+    _profile.cardType = (uint8_t)SD.cardType();
+    _profile.reserved = 0;
+    saveProfile();
+}
+
+bool SDManager::mount(uint32_t frequency)
+{
+    SD.end();
+    if (!SD.begin(_csPin, SPI, frequency))
+    {
+        return false;
+    }
+    return SD.cardType() != CARD_NONE;
+}
+
+bool SDManager::verify()
+{
+    uint8_t pattern[SD_PROBE_BYTES];
+    uint8_t readback[SD_PROBE_BYTES];
+    for (uint16_t i = 0; i < SD_PROBE_BYTES; i++)
+    {
+        pattern[i] = (uint8_t)(i * 31 + 7); // Mixed bit pattern
+    }
+
+    File file = SD.open(SD_PROBE_FILE, FILE_WRITE);
+    if (!file)
+    {
+        return false;
+    }
+    size_t written = file.write(pattern, sizeof(pattern));
+    file.close();
+    if (written != sizeof(pattern))
+    {
+        return false;
+    }
+
+    file = SD.open(SD_PROBE_FILE, FILE_READ);
+    if (!file)
+    {
+        return false;
+    }
+    size_t bytesRead = file.read(readback, sizeof(readback));
+    file.close();
+    SD.remove(SD_PROBE_FILE);
+
+    return bytesRead == sizeof(readback) && memcmp(pattern, readback, sizeof(pattern)) == 0;
+}
+
+int SDManager::frequencyIndex(uint32_t frequency)
+{
+    for (uint8_t i = 0; i < NUM_FREQUENCIES; i++)
+    {
+        if (_frequencies[i] == frequency)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool SDManager::isValid(const SDProfile &profile)
+{
+    return profile.magic == SD_PROFILE_MAGIC && frequencyIndex(profile.frequency) >= 0;
+}
+
+bool SDManager::loadProfile()
+{
+    SDProfile stored;
+    _preferences.begin(PREFS_NAMESPACE, true);
+    size_t length = _preferences.getBytes("sdProfile", &stored, sizeof(stored));
+    _preferences.end();
+
+    if (length != sizeof(stored) || !isValid(stored))
+    {
+        return false;
+    }
+    _profile = stored;
+    return true;
+}
+
+void SDManager::saveProfile()
+{
+    // Only write NVS when the negotiated profile actually changes
+    SDProfile stored;
+    _preferences.begin(PREFS_NAMESPACE, false);
+    size_t length = _preferences.getBytes("sdProfile", &stored, sizeof(stored));
+    if (length != sizeof(stored) || memcmp(&stored, &_profile, sizeof(stored)) != 0)
+    {
+        _preferences.putBytes("sdProfile", &_profile, sizeof(_profile));
+    }
+    _preferences.end();
+}
+
+void SDManager::benchmark()
+{
+    const uint16_t flushSizes[] = {64, 512, 4096, 16384};
+    uint8_t chunk[512];
+    memset(chunk, 'A', sizeof(chunk));
+
+    Serial.println("\nSD benchmark:");
+    Serial.println("---------------------------");
+    Serial.printf("Clock: %lu Hz, type: %d, sector: %d\n",
+                  (unsigned long)_profile.frequency, _profile.cardType, _profile.sectorSize);
+
+    for (uint8_t s = 0; s < sizeof(flushSizes) / sizeof(flushSizes[0]); s++)
+    {
+        uint16_t size = flushSizes[s];
+        uint32_t totalMicros = 0;
+        uint32_t minMicros = UINT32_MAX;
+        uint32_t maxMicros = 0;
+        bool ok = true;
+
+        SD.remove(SD_BENCH_FILE);
+        for (uint8_t n = 0; n < SD_BENCH_FLUSHES && ok; n++)
+        {
+            // Each flush mirrors logData(): open, append, close
+            uint32_t start = micros();
+            File file = SD.open(SD_BENCH_FILE, FILE_APPEND);
+            if (!file)
+            {
+                ok = false;
+                break;
+            }
+            uint16_t remaining = size;
+            while (remaining > 0)
+            {
+                uint16_t len = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+                if (file.write(chunk, len) != len)
+                {
+                    ok = false;
+                    break;
+                }
+                remaining -= len;
+            }
+            file.close();
+            uint32_t elapsed = micros() - start;
+
+            totalMicros += elapsed;
+            minMicros = min(minMicros, elapsed);
+            maxMicros = max(maxMicros, elapsed);
+        }
+
+        if (!ok)
+        {
+            Serial.printf("%5d B: write failed\n", size);
+            continue;
+        }
+
+        float kbPerSecond = ((float)size * SD_BENCH_FLUSHES / 1024.0) / (totalMicros / 1000000.0);
+        Serial.printf("%5d B: %7.1f KB/s, latency avg %lu us, min %lu us, max %lu us\n",
+                      size, kbPerSecond, (unsigned long)(totalMicros / SD_BENCH_FLUSHES),
+                      (unsigned long)minMicros, (unsigned long)maxMicros);
+    }
+    SD.remove(SD_BENCH_FILE);
+    Serial.println("---------------------------\n");
+}
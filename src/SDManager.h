@@ -0,0 +1,57 @@
+#ifndef SD_MANAGER_H
+#define SD_MANAGER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <SPI.h>
+#include <Preferences.h>
+#include "SharedDefs.h"
+
+#define SD_PROFILE_MAGIC 0x53444350 // "SDCP"
+#define SD_PROBE_FILE "/.sdprobe"
+#define SD_PROBE_BYTES 512
+#define SD_BENCH_FILE "/.sdbench"
+#define SD_BENCH_FLUSHES 16 // Flushes timed per size in benchmark()
+
+// Card profile negotiated on cold boot, cached in RTC memory and NVS
+struct SDProfile
+{
+    uint32_t magic;
+    uint32_t frequency;
+    uint16_t sectorSize;
+    uint8_t cardType;
+    uint8_t reserved;
+};
+
+class SDManager
+{
+public:
+    SDManager();
+    bool begin(uint8_t csPin, bool isWakeFromSleep);
+    bool handleIOError(); // Step down to the next stable clock and remount
+    void benchmark();
+
+    uint32_t getFrequency() const { return _profile.frequency; }
+    uint8_t getCardType() const { return _profile.cardType; }
+    uint16_t getSectorSize() const { return _profile.sectorSize; }
+
+private:
+    uint8_t _csPin;
+    Preferences _preferences;
+
+    bool probe(uint8_t startIndex);
+    bool mount(uint32_t frequency);
+    bool verify();
+    void remember(uint32_t frequency); // Cache a working clock in RTC memory and NVS
+    int frequencyIndex(uint32_t frequency);
+    bool isValid(const SDProfile &profile);
+    bool loadProfile();
+    void saveProfile();
+
+    RTC_DATA_ATTR static SDProfile _profile; // Persists in RTC memory
+    RTC_DATA_ATTR static bool _probeFailed;  // Every clock failed, skip renegotiation on wake
+    static const uint32_t _frequencies[];
+    static const uint8_t NUM_FREQUENCIES;
+};
+
+#endif // SD_MANAGER_H
@@ -15,4 +15,11 @@ enum class RTCType
     UNKNOWN
 };
 
+// Where logData() writes rows
+enum class StorageMode
+{
+    SD_DIRECT,   // Append every row straight to the SD day file
+    FLASH_STAGED // Stage rows in internal flash, migrate to SD in batches
+};
+
 #endif
\ No newline at end of file
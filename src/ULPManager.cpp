@@ -32,7 +32,7 @@ void ULPManager::begin()
     Serial.println("  ULP: initialization complete");
 }
 
-void ULPManager::start()
+bool ULPManager::start()
 {
     Serial.println("  ULP: starting program");
 
@@ -82,16 +82,17 @@ void ULPManager::start()
     if (err != ESP_OK)
     {
         Serial.printf("  ULP: program load error: %d\n", err);
-        return;
+        return false;
     }
 
     err = ulp_run(PROG_START);
     if (err != ESP_OK)
     {
         Serial.printf("  ULP: start error: %d\n", err);
-        return;
+        return false;
     }
     Serial.println("  ULP: program started");
+    return true;
 }
 
 uint16_t ULPManager::getEdgeCount()
@@ -18,7 +18,7 @@ class ULPManager
 public:
     ULPManager();
     void begin();
-    void start();
+    bool start();
     uint16_t getEdgeCount();
     void clearEdgeCount();
     void setSensorPin(gpio_num_t pin);
@@ -0,0 +1,69 @@
+#ifndef SIMULATED_PARTITION_H
+#define SIMULATED_PARTITION_H
+
+#include <string.h>
+#include <vector>
+#include "FlashLog.h"
+
+// In-memory NOR flash: erase sets bytes to 0xFF, writes can only clear bits.
+// failAfterBytes simulates power loss part-way through a write.
+class SimulatedPartition : public FlashLogStorage
+{
+public:
+    explicit SimulatedPartition(uint16_t sectors)
+        : _data((size_t)sectors * FLASH_LOG_SECTOR_SIZE, 0xFF), failAfterBytes(-1), erases(0) {}
+
+    uint32_t size() override { return (uint32_t)_data.size(); }
+
+    bool read(uint32_t offset, void *data, size_t length) override
+    {
+        if (offset + length > _data.size())
+        {
+            return false;
+        }
+        memcpy(data, &_data[offset], length);
+        return true;
+    }
+
+    bool write(uint32_t offset, const void *data, size_t length) override
+    {
+        if (offset + length > _data.size())
+        {
+            return false;
+        }
+        const uint8_t *bytes = (const uint8_t *)data;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (failAfterBytes == 0)
+            {
+                return false;
+            }
+            if (failAfterBytes > 0)
+            {
+                failAfterBytes--;
+            }
+            _data[offset + i] &= bytes[i];
+        }
+        return true;
+    }
+
+    bool eraseSector(uint32_t offset) override
+    {
+        if (offset % FLASH_LOG_SECTOR_SIZE != 0 || offset >= _data.size())
+        {
+            return false;
+        }
+        memset(&_data[offset], 0xFF, FLASH_LOG_SECTOR_SIZE);
+        erases++;
+        return true;
+    }
+
+private:
+    std::vector<uint8_t> _data;
+
+public:
+    long failAfterBytes;
+    uint32_t erases;
+};
+
+#endif // SIMULATED_PARTITION_H
@@ -0,0 +1,175 @@
+// Host test for FlashLog against a simulated NOR partition.
+#include <stdio.h>
+#include "FlashLog.h"
+#include "SimulatedPartition.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static FlashLogRecord makeRecord(uint32_t i)
+{
+    FlashLogRecord record;
+    record.timestamp = 1700000000 + i;
+    record.voltage = 3.7f;
+    record.count = (uint16_t)i;
+    return record;
+}
+
+// Drain count records and check they come back in append order from first
+static void drain(FlashLog &log, uint32_t first, uint32_t count)
+{
+    FlashLogRecord records[64];
+    uint32_t expected = first;
+    while (count > 0)
+    {
+        uint16_t n = log.peek(records, count < 64 ? (uint16_t)count : 64);
+        CHECK(n > 0);
+        if (n == 0)
+        {
+            return;
+        }
+        for (uint16_t i = 0; i < n; i++)
+        {
+            CHECK(records[i].timestamp == 1700000000 + expected);
+            expected++;
+        }
+        CHECK(log.consume(n));
+        count -= n;
+    }
+}
+
+static void testWrap()
+{
+    SimulatedPartition flash(3);
+    FlashLog log;
+    CHECK(log.begin(&flash));
+
+    // Several laps around the ring, keeping it part full
+    uint32_t written = 0;
+    uint32_t read = 0;
+    for (int lap = 0; lap < 10; lap++)
+    {
+        for (int i = 0; i < 300; i++)
+        {
+            CHECK(log.append(makeRecord(written++)));
+        }
+        CHECK(log.pendingCount() == written - read);
+        drain(log, read, 300);
+        read += 300;
+        CHECK(log.pendingCount() == 0);
+    }
+    CHECK(flash.erases > 10);
+}
+
+static void testFullRing()
+{
+    SimulatedPartition flash(3);
+    FlashLog log;
+    CHECK(log.begin(&flash));
+
+    // One sector is held back, so the ring stops at two sectors of entries
+    const uint32_t capacity = 2 * FLASH_LOG_ENTRIES_PER_SECTOR;
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        CHECK(log.append(makeRecord(i)));
+    }
+    CHECK(log.fillPercent() == 100);
+    CHECK(!log.append(makeRecord(capacity)));
+    CHECK(log.pendingCount() == capacity);
+
+    // Freeing the oldest sector makes room again
+    drain(log, 0, FLASH_LOG_ENTRIES_PER_SECTOR);
+    CHECK(log.append(makeRecord(capacity)));
+    drain(log, FLASH_LOG_ENTRIES_PER_SECTOR, FLASH_LOG_ENTRIES_PER_SECTOR + 1);
+    CHECK(log.pendingCount() == 0);
+}
+
+static void testTornEntry()
+{
+    SimulatedPartition flash(3);
+    FlashLog log;
+    CHECK(log.begin(&flash));
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        CHECK(log.append(makeRecord(i)));
+    }
+
+    // Power lost part-way through the 11th entry
+    flash.failAfterBytes = 6;
+    CHECK(!log.append(makeRecord(10)));
+    flash.failAfterBytes = -1;
+
+    // After reboot the torn slot is skipped, not reused or returned
+    FlashLog rebooted;
+    CHECK(rebooted.begin(&flash));
+    CHECK(rebooted.append(makeRecord(11)));
+    FlashLogRecord records[16];
+    uint16_t n = rebooted.peek(records, 16);
+    CHECK(n == 11);
+    CHECK(records[9].count == 9);
+    CHECK(records[10].count == 11);
+    CHECK(rebooted.consume(n));
+    CHECK(rebooted.pendingCount() == 0);
+}
+
+static void testRebootTailRecovery()
+{
+    SimulatedPartition flash(4);
+    uint32_t written = 0;
+    uint32_t read = 0;
+    {
+        FlashLog log;
+        CHECK(log.begin(&flash));
+        // Wrap once so the oldest sector is not sector 0
+        for (uint32_t i = 0; i < 3 * FLASH_LOG_ENTRIES_PER_SECTOR; i++)
+        {
+            CHECK(log.append(makeRecord(written++)));
+        }
+        drain(log, read, 2 * FLASH_LOG_ENTRIES_PER_SECTOR + 7);
+        read += 2 * FLASH_LOG_ENTRIES_PER_SECTOR + 7;
+        for (uint32_t i = 0; i < FLASH_LOG_ENTRIES_PER_SECTOR + 20; i++)
+        {
+            CHECK(log.append(makeRecord(written++)));
+        }
+        drain(log, read, 100);
+        read += 100;
+    }
+
+    // Head and tail come back from flash alone
+    FlashLog log;
+    CHECK(log.begin(&flash));
+    CHECK(log.pendingCount() == written - read);
+    CHECK(log.append(makeRecord(written++)));
+    drain(log, read, written - read);
+    CHECK(log.pendingCount() == 0);
+
+    // An empty log also recovers as empty
+    FlashLog empty;
+    CHECK(empty.begin(&flash));
+    CHECK(empty.pendingCount() == 0);
+}
+
+int main()
+{
+    testWrap();
+    testFullRing();
+    testTornEntry();
+    testRebootTailRecovery();
+
+    if (failures > 0)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All FlashLog tests passed\n");
+    return 0;
+}